@@ -0,0 +1,357 @@
+// Benchmarks
+// ** Times zone loading, collision queries, culled tile rendering and a
+// **  whole game frame on procedurally generated zones, from the real
+// **  40x30 size up to 4096x4096, and prints the results as JSON.
+// ** Built as its own program from the same engine source:
+// **   g++ -O2 LoCbench.cpp -o LoCbench -lSDL -lSDL_image -lSDL_ttf -lSDL_mixer
+// ** Usage:
+// **   LoCbench [--max-size N] [--density D] [--seed S] [--maps DIR]
+// **            [--output FILE] [--generate-only]
+#define LOC_BENCHMARK
+#include "LoCmain.cpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+#include <time.h>
+#include <sys/stat.h>
+
+// Benchmark constants
+// ** Generated zones go to a scratch directory, away from Zones/ which
+// **  holds the game's maps and is watched for hot-reload.
+const std::string BENCH_MAP_DIR = "bench_maps";
+const int TOTAL_BENCH_SIZES = 6;
+const int BENCH_SIZES[TOTAL_BENCH_SIZES][2] = {
+  {40,30}, {128,96}, {512,384}, {1024,1024}, {2048,2048}, {4096,4096}
+};
+// ** Each benchmark gets roughly this many tile visits, so small zones
+// **  run many iterations and huge zones still finish.
+const double BENCH_TILE_BUDGET = 50000000.0;
+const int BENCH_MAX_ITERATIONS = 2000;
+const int BENCH_MIN_ITERATIONS = 3;
+
+//*******************************\\
+//***CLASS DECLARATIONS ***
+// ** Deterministic generator so a given seed produces the same zone on
+// **  every platform; rand() differs between C libraries.
+class ZoneRandom {
+  private:
+    unsigned int state;
+  public:
+    ZoneRandom(unsigned int seed);
+    unsigned int next();
+    int range(int low, int high);
+    double unit();
+};
+// ** Collects the per-iteration times of one benchmark.
+class BenchResult {
+  private:
+    std::string name;
+    int tilesAcross, tilesDown;
+    std::vector<double> samples;
+  public:
+    BenchResult(std::string benchName, int across, int down);
+    void add(double micros);
+    std::string to_json();
+};
+//*******************************\\
+//*** GENERAL FUNCTIONS ***
+//now_micros
+double now_micros() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000.0 + now.tv_nsec / 1000.0;
+}
+//bench_iterations
+int bench_iterations(int totalTiles) {
+  int iterations = (int)(BENCH_TILE_BUDGET / totalTiles);
+  if (iterations < BENCH_MIN_ITERATIONS) { iterations = BENCH_MIN_ITERATIONS; }
+  if (iterations > BENCH_MAX_ITERATIONS) { iterations = BENCH_MAX_ITERATIONS; }
+  return iterations;
+}
+//zone_filename
+std::string zone_filename(std::string dir, int across, int down) {
+  std::stringstream name;
+  name << dir << "/bench_" << across << "x" << down << ".map";
+  return name.str();
+}
+//generate_zone
+// ** Writes a zone in the same format as Zones/zoneOne.map. Each tile is
+// **  impassable with probability density, otherwise passable.
+bool generate_zone(std::string filename, int across, int down, double density, unsigned int seed) {
+  std::ofstream map(filename.c_str());
+  if (map.is_open() == false) { return false; }
+
+  ZoneRandom random(seed);
+  for (int y = 0; y < down; y++) {
+    for (int x = 0; x < across; x++) {
+      int tileType;
+      if (random.unit() < density) { tileType = random.range(TILE_SmallTreeOne, TILE_RockTwoGrass); }
+      else { tileType = random.range(TILE_GrassOne, TILE_GrassBush); }
+      if (x > 0) { map << ' '; }
+      map << tileType;
+    }//end for
+    map << '\n';
+  }//end for
+  map.close();
+  return (map.fail() == false);
+}
+//free_tiles
+void free_tiles(std::vector<Tile*> &tiles) {
+  for (unsigned int t = 0; t < tiles.size(); t++) { delete tiles[t]; tiles[t] = NULL; }
+}
+//make_surface
+// ** Off-screen stand-ins for the display and sprite sheets, so the
+// **  benchmarks need neither a window nor the game's assets.
+SDL_Surface *make_surface(int w, int h) {
+  SDL_Surface *surface = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, SCREEN_BPP, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+  if (surface != NULL) { SDL_FillRect(surface, NULL, 0xFF336633); }
+  return surface;
+}
+//bench_load
+void bench_load(std::vector<BenchResult> &results, std::string filename, int across, int down) {
+  int totalTiles = across * down;
+  std::vector<int> types(totalTiles);
+  std::vector<Tile*> tiles(totalTiles, (Tile*)NULL);
+  BenchResult result("map_load", across, down);
+
+  int iterations = bench_iterations(totalTiles) / 10;
+  if (iterations < BENCH_MIN_ITERATIONS) { iterations = BENCH_MIN_ITERATIONS; }
+  for (int i = 0; i < iterations; i++) {
+    double start = now_micros();
+    bool loaded = read_zone(filename, &types[0], totalTiles);
+    if (loaded == true) { place_tiles(&tiles[0], &types[0], across * TILE_WIDTH, totalTiles); }
+    double stop = now_micros();
+    if (loaded == false) { fprintf(stderr, "could not load %s\n", filename.c_str()); return; }
+    result.add(stop - start);
+    free_tiles(tiles);
+  }//end for
+  results.push_back(result);
+}
+//bench_collision
+void bench_collision(std::vector<BenchResult> &results, Tile *tiles[], int across, int down) {
+  int totalTiles = across * down;
+  ZoneRandom random(across * 7919 + down);
+  BenchResult result("collision_query", across, down);
+  int hits = 0;
+
+  int iterations = bench_iterations(totalTiles);
+  for (int i = 0; i < iterations; i++) {
+    ZoneRect box;
+    box.x = random.range(0, across * TILE_WIDTH - CHAR_SPRITE_WIDTH);
+    box.y = random.range(0, down * TILE_HEIGHT - CHAR_SPRITE_HEIGHT);
+    box.w = CHAR_SPRITE_WIDTH;
+    box.h = CHAR_SPRITE_HEIGHT;
+
+    double start = now_micros();
+    if (touches_wall(box, tiles, totalTiles) == true) { hits++; }
+    result.add(now_micros() - start);
+  }//end for
+  // ** Report the hit count so the queries cannot be optimized away.
+  fprintf(stderr, "  collision %dx%d: %d/%d hits\n", across, down, hits, iterations);
+  results.push_back(result);
+}
+//bench_render
+// ** Moves the camera across the zone and draws every visible tile into
+// **  the off-screen surface. Tile::show() does the culling.
+void bench_render(std::vector<BenchResult> &results, Tile *tiles[], int across, int down) {
+  int totalTiles = across * down;
+  ZoneRandom random(across * 104729 + down);
+  BenchResult result("render_culled", across, down);
+
+  int iterations = bench_iterations(totalTiles);
+  for (int i = 0; i < iterations; i++) {
+    camera.x = random.range(0, across * TILE_WIDTH - SCREEN_WIDTH);
+    camera.y = random.range(0, down * TILE_HEIGHT - SCREEN_HEIGHT);
+
+    double start = now_micros();
+    show_tiles(tiles, totalTiles);
+    result.add(now_micros() - start);
+  }//end for
+  results.push_back(result);
+}
+//is_passable
+bool is_passable(Tile *tiles[], int across, int x, int y) {
+  return (tiles[y * across + x]->get_type() < TILE_SmallTreeOne);
+}
+//find_open_spot
+// ** Finds a 2x2 block of passable tiles, searching from the middle of
+// **  the zone, so a character moving right and down from its top-left
+// **  tile never touches a wall.
+bool find_open_spot(Tile *tiles[], int across, int down, int &spotX, int &spotY) {
+  int cells = (across - 1) * (down - 1);
+  int middle = (down / 2) * (across - 1) + across / 2;
+  for (int c = 0; c < cells; c++) {
+    int x = (middle + c) % cells % (across - 1);
+    int y = (middle + c) % cells / (across - 1);
+    if (is_passable(tiles, across, x, y) && is_passable(tiles, across, x + 1, y) &&
+        is_passable(tiles, across, x, y + 1) && is_passable(tiles, across, x + 1, y + 1)) {
+      spotX = x;
+      spotY = y;
+      return true;
+    }
+  }//end for
+  return false;
+}
+//bench_frame
+// ** One pass of the game loop body: camera, movement with collision,
+// **  tile rendering and the character sprite. The character walks with
+// **  the arrow keys held down, the same way handle_events() sees input.
+// ** It is put back on an open spot before every frame, so both
+// **  touches_wall() calls in move() scan the whole zone without a hit.
+void bench_frame(std::vector<BenchResult> &results, Tile *tiles[], int across, int down) {
+  int totalTiles = across * down;
+  BenchResult result("frame", across, down);
+  Character mainChar;
+
+  int spotX, spotY;
+  if (find_open_spot(tiles, across, down, spotX, spotY) == false) {
+    fprintf(stderr, "  frame %dx%d: no open spot, skipped\n", across, down);
+    return;
+  }
+  int startX = spotX * TILE_WIDTH;
+  int startY = spotY * TILE_HEIGHT;
+
+  event.type = SDL_KEYDOWN;
+  event.key.keysym.sym = SDLK_RIGHT;
+  mainChar.handle_events();
+  event.key.keysym.sym = SDLK_DOWN;
+  mainChar.handle_events();
+
+  int blocked = 0;
+  int iterations = bench_iterations(totalTiles);
+  for (int i = 0; i < iterations; i++) {
+    mainChar.set_x(startX);
+    mainChar.set_y(startY);
+
+    double start = now_micros();
+    mainChar.set_camera(across * TILE_WIDTH, down * TILE_HEIGHT);
+    mainChar.move(tiles, across * TILE_WIDTH, down * TILE_HEIGHT, totalTiles);
+    show_tiles(tiles, totalTiles);
+    mainChar.show();
+    result.add(now_micros() - start);
+
+    if ((mainChar.get_x() == startX) || (mainChar.get_y() == startY)) { blocked++; }
+  }//end for
+  if (blocked > 0) { fprintf(stderr, "  frame %dx%d: %d/%d moves blocked\n", across, down, blocked, iterations); }
+  results.push_back(result);
+}
+//*******************************\\
+//*** CLASS FUNCTIONS ***
+//***ZONERANDOM
+ZoneRandom::ZoneRandom(unsigned int seed) { state = seed; }
+unsigned int ZoneRandom::next() {
+  state = state * 1664525u + 1013904223u;
+  return state >> 8;
+}
+int ZoneRandom::range(int low, int high) { return low + (int)(next() % (unsigned int)(high - low + 1)); }
+double ZoneRandom::unit() { return next() / 16777216.0; }
+//***BENCHRESULT
+BenchResult::BenchResult(std::string benchName, int across, int down) {
+  name = benchName;
+  tilesAcross = across;
+  tilesDown = down;
+}
+void BenchResult::add(double micros) { samples.push_back(micros); }
+std::string BenchResult::to_json() {
+  double total = 0, fastest = 0, slowest = 0;
+  for (unsigned int s = 0; s < samples.size(); s++) {
+    total += samples[s];
+    if ((s == 0) || (samples[s] < fastest)) { fastest = samples[s]; }
+    if ((s == 0) || (samples[s] > slowest)) { slowest = samples[s]; }
+  }
+  double mean = 0;
+  if (samples.empty() == false) { mean = total / samples.size(); }
+
+  std::stringstream json;
+  json << "{\"name\": \"" << name << "\", \"width\": " << tilesAcross << ", \"height\": " << tilesDown
+       << ", \"tiles\": " << tilesAcross * tilesDown << ", \"iterations\": " << samples.size()
+       << ", \"mean_us\": " << mean << ", \"min_us\": " << fastest << ", \"max_us\": " << slowest << "}";
+  return json.str();
+}
+//***END CLASS FUNCTIONS***
+//*******************************\\
+//***MAIN
+int main(int argc, char* args[]) {
+
+int maxSize = 4096;
+double density = 0.2;
+unsigned int seed = 1;
+std::string mapDir = BENCH_MAP_DIR;
+std::string output = "";
+bool generateOnly = false;
+
+for (int a = 1; a < argc; a++) {
+  std::string option = args[a];
+  bool hasValue = (a + 1 < argc);
+  if ((option == "--max-size") && hasValue) { maxSize = atoi(args[++a]); }
+  else if ((option == "--density") && hasValue) { density = atof(args[++a]); }
+  else if ((option == "--seed") && hasValue) { seed = (unsigned int)strtoul(args[++a], NULL, 10); }
+  else if ((option == "--maps") && hasValue) { mapDir = args[++a]; }
+  else if ((option == "--output") && hasValue) { output = args[++a]; }
+  else if (option == "--generate-only") { generateOnly = true; }
+  else { fprintf(stderr, "unknown option %s\n", option.c_str()); return 1; }
+}
+if ((density < 0) || (density > 1)) { fprintf(stderr, "density must be between 0 and 1\n"); return 1; }
+if ((mkdir(mapDir.c_str(), 0755) == -1) && (errno != EEXIST)) {
+  fprintf(stderr, "could not create %s: %s\n", mapDir.c_str(), strerror(errno));
+  return 1;
+}
+
+screen = make_surface(SCREEN_WIDTH, SCREEN_HEIGHT);
+generalScene = make_surface(TILE_WIDTH * 5, TILE_HEIGHT * (TILE_GrassBush + 1));
+mainCharSpriteSheet = make_surface(CHAR_SPRITE_WIDTH * 9, CHAR_SPRITE_HEIGHT * 8);
+if ((screen == NULL) || (generalScene == NULL) || (mainCharSpriteSheet == NULL)) { return 1; }
+set_clips();
+
+std::vector<BenchResult> results;
+for (int s = 0; s < TOTAL_BENCH_SIZES; s++) {
+  int across = BENCH_SIZES[s][0];
+  int down = BENCH_SIZES[s][1];
+  if ((across > maxSize) || (down > maxSize)) { continue; }
+  int totalTiles = across * down;
+  std::string filename = zone_filename(mapDir, across, down);
+
+  fprintf(stderr, "generating %s\n", filename.c_str());
+  if (generate_zone(filename, across, down, density, seed + s) == false) {
+    fprintf(stderr, "could not write %s\n", filename.c_str());
+    return 1;
+  }
+  if (generateOnly == true) { continue; }
+
+  fprintf(stderr, "benchmarking %dx%d\n", across, down);
+  bench_load(results, filename, across, down);
+
+  std::vector<int> types(totalTiles);
+  std::vector<Tile*> tiles(totalTiles, (Tile*)NULL);
+  if (read_zone(filename, &types[0], totalTiles) == false) { return 1; }
+  place_tiles(&tiles[0], &types[0], across * TILE_WIDTH, totalTiles);
+
+  bench_collision(results, &tiles[0], across, down);
+  bench_render(results, &tiles[0], across, down);
+  bench_frame(results, &tiles[0], across, down);
+  free_tiles(tiles);
+}//end for
+
+std::stringstream json;
+json << "{\n  \"benchmark\": \"LoCbench\",\n  \"density\": " << density << ",\n  \"seed\": " << seed
+     << ",\n  \"results\": [";
+for (unsigned int r = 0; r < results.size(); r++) {
+  if (r > 0) { json << ","; }
+  json << "\n    " << results[r].to_json();
+}
+json << "\n  ]\n}\n";
+
+if (output.empty() == true) { fputs(json.str().c_str(), stdout); }
+else {
+  std::ofstream file(output.c_str());
+  file << json.str();
+  file.close();
+  if (file.fail() == true) { fprintf(stderr, "could not write %s\n", output.c_str()); return 1; }
+}
+
+SDL_FreeSurface(screen);
+SDL_FreeSurface(generalScene);
+SDL_FreeSurface(mainCharSpriteSheet);
+return 0;
+}
@@ -6,10 +6,18 @@
 #include "SDL/SDL_image.h"
 #include "SDL/SDL_ttf.h"
 #include "SDL/SDL_mixer.h"
+#include "SDL/SDL_thread.h"
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <cstdio>
+// ** Zone hot-reload listens for file changes through inotify on Linux.
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
 
 // Screen constants
 const int SCREEN_WIDTH = 640;
@@ -23,6 +31,10 @@ const int TILE_WIDTH = 32;
 const int TILE_HEIGHT = 32;
 const int TOTAL_TILES = 1200;
 const int TOTAL_SPRITES = 40;
+// Zone files
+const std::string ZONE_DIR = "Zones";
+const std::string ZONE_NAME = "zoneOne.map";
+const std::string ZONE_FILE = ZONE_DIR + "/" + ZONE_NAME;
 // Static tiles
 // ** I've set the tiles to be represented with ID's
 // ** The splice function that disects the loaded img file assigns
@@ -102,19 +114,41 @@ SDL_Color textColor = {0,0,0};
 SDL_Rect tileClips[TOTAL_SPRITES];
 //Events
 SDL_Event event;
+//Zone rectangles
+// ** SDL_Rect holds 16-bit positions, which wrap on zones more than
+// **  2048 tiles across. Zone positions are kept as ints; an SDL_Rect is
+// **  only built when blitting relative to the camera.
+struct ZoneRect {
+  int x, y;
+  int w, h;
+};
 //Camera
-SDL_Rect camera = {0,0,SCREEN_WIDTH,SCREEN_HEIGHT};
+ZoneRect camera = {0,0,SCREEN_WIDTH,SCREEN_HEIGHT};
+//Zone hot-reload
+// ** The watcher thread re-reads the zone file whenever it is saved,
+// **  diffs it against its copy of the live tile types and queues only
+// **  the cells that changed. The main thread applies the queue.
+struct TileChange {
+  int index;
+  int type;
+};
+SDL_Thread *zoneWatcher = NULL;
+SDL_mutex *zoneLock = NULL;
+bool zoneWatchQuit = false;
+int zoneTypes[TOTAL_TILES];
+std::vector<TileChange> zoneChanges;
 //*******************************\\
 //***CLASS DECLARATIONS ***
 class Tile {
   private:
-    SDL_Rect box;
+    ZoneRect box;
     int type;
   public:
     Tile(int x, int y, int tileType);
     void show();
     int get_type();
-    SDL_Rect &get_box();
+    void set_type(int tileType);
+    ZoneRect &get_box();
 };
 // ** Timer represents how the application regulates frame rates
 // **  and occurance of accepting user input.
@@ -136,16 +170,16 @@ class Timer {
 };
 class Character {
   private:
-    SDL_Rect box;
+    ZoneRect box;
     int xVel, yVel;
     int frame;
     int status;
   public:
     Character();
     void handle_events();
-    void move(Tile *tiles[]);
+    void move(Tile *tiles[], int zoneWidth = ZONE_WIDTH, int zoneHeight = ZONE_HEIGHT, int totalTiles = TOTAL_TILES);
     void show();
-    void set_camera();
+    void set_camera(int zoneWidth = ZONE_WIDTH, int zoneHeight = ZONE_HEIGHT);
     //Saves/Loads
     void set_x(int X);
     void set_y(int Y);
@@ -177,7 +211,7 @@ void apply_surface(int x, int y, SDL_Surface *source, SDL_Surface *destination,
   SDL_BlitSurface(source,clip,destination,&offset);
 }
 //check_collision
-bool check_collision(SDL_Rect A, SDL_Rect B) {
+bool check_collision(ZoneRect A, ZoneRect B) {
   int leftA, leftB;
   int rightA, rightB;
   int topA, topB;
@@ -459,34 +493,142 @@ void set_clips() {
   tileClips[TILE_RockTwoGrass].w = TILE_WIDTH;
   tileClips[TILE_RockTwoGrass].h = TILE_HEIGHT;
 }
-//set_tiles
-bool set_tiles(Tile *tiles[]) {
-  int x = 0, y = 0;
-  std::ifstream map("Zones/zoneOne.map");
-  if (map == NULL) { return false; }
-  
-  for (int t = 0; t < TOTAL_TILES; t++) {
+//read_zone
+// ** Parses a zone file into an array of tile types. Nothing is
+// **  written to the live tiles, so the watcher thread can use it too.
+bool read_zone(std::string filename, int types[], int totalTiles = TOTAL_TILES) {
+  std::ifstream map(filename.c_str());
+  if (map.is_open() == false) { return false; }
+  
+  for (int t = 0; t < totalTiles; t++) {
     int tileType = -1;
     map >> tileType;
     if (map.fail() == true) { map.close(); return false; }
-    if ((tileType >= 0) && (tileType < TOTAL_SPRITES)) { tiles[t] = new Tile(x,y,tileType); }
+    if ((tileType >= 0) && (tileType < TOTAL_SPRITES)) { types[t] = tileType; }
     else { map.close(); return false; }
+  }//end for
+  map.close();
+  return true;
+}
+//place_tiles
+// ** Lays tiles out row by row. zoneWidth is in pixels.
+void place_tiles(Tile *tiles[], int types[], int zoneWidth = ZONE_WIDTH, int totalTiles = TOTAL_TILES) {
+  int x = 0, y = 0;
+  for (int t = 0; t < totalTiles; t++) {
+    tiles[t] = new Tile(x,y,types[t]);
     
     x += TILE_WIDTH;
-    if (x >= ZONE_WIDTH) { x = 0; y += TILE_HEIGHT; }
+    if (x >= zoneWidth) { x = 0; y += TILE_HEIGHT; }
   }//end for
-  map.close();
+}
+//set_tiles
+bool set_tiles(Tile *tiles[]) {
+  if (read_zone(ZONE_FILE, zoneTypes) == false) { return false; }
+  place_tiles(tiles, zoneTypes);
   return true;
 }
-//touches_wall
-bool touches_wall(SDL_Rect box, Tile *tiles[]) {
+//reload_zone
+// ** Runs on the watcher thread. A half-written or broken file is
+// **  reported and ignored; the next save will trigger another attempt.
+void reload_zone() {
+  std::vector<int> newTypes(TOTAL_TILES);
+  if (read_zone(ZONE_FILE, &newTypes[0]) == false) {
+    fprintf(stderr, "%s: could not reload zone, expected %d tile types from 0 to %d\n", ZONE_FILE.c_str(), TOTAL_TILES, TOTAL_SPRITES - 1);
+    return;
+  }
+  
+  SDL_mutexP(zoneLock);
   for (int t = 0; t < TOTAL_TILES; t++) {
+    if (newTypes[t] != zoneTypes[t]) {
+      TileChange change = {t, newTypes[t]};
+      zoneChanges.push_back(change);
+      zoneTypes[t] = newTypes[t];
+    }
+  }//end for
+  SDL_mutexV(zoneLock);
+}
+//watch_zone
+// ** Watcher thread body. The directory is watched rather than the file
+// **  because most editors save by writing a new file and renaming it.
+int watch_zone(void *) {
+#ifdef __linux__
+  int watch = inotify_init();
+  if (watch == -1) { return 1; }
+  if (inotify_add_watch(watch, ZONE_DIR.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1) { close(watch); return 1; }
+  
+  char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  while (true) {
+    SDL_mutexP(zoneLock);
+    bool quit = zoneWatchQuit;
+    SDL_mutexV(zoneLock);
+    if (quit == true) { break; }
+    
+    // ** Wake up regularly so stop_zone_watch() never waits long.
+    pollfd pending = {watch, POLLIN, 0};
+    if (poll(&pending, 1, 250) <= 0) { continue; }
+    ssize_t length = read(watch, buffer, sizeof(buffer));
+    if (length <= 0) { continue; }
+    
+    bool changed = false;
+    for (char *p = buffer; p < buffer + length; ) {
+      struct inotify_event *notice = (struct inotify_event *)p;
+      if ((notice->len > 0) && (ZONE_NAME == notice->name)) { changed = true; }
+      p += sizeof(struct inotify_event) + notice->len;
+    }//end for
+    if (changed == true) { reload_zone(); }
+  }//end while
+  close(watch);
+#endif
+  return 0;
+}
+//start_zone_watch
+// ** Hot-reload is a convenience for level editing, so a failure here
+// **  leaves the game running with the map it already loaded.
+bool start_zone_watch() {
+  zoneLock = SDL_CreateMutex();
+  if (zoneLock == NULL) { return false; }
+  zoneWatchQuit = false;
+  zoneWatcher = SDL_CreateThread(watch_zone, NULL);
+  if (zoneWatcher == NULL) { SDL_DestroyMutex(zoneLock); zoneLock = NULL; return false; }
+  return true;
+}
+//stop_zone_watch
+void stop_zone_watch() {
+  if (zoneWatcher != NULL) {
+    SDL_mutexP(zoneLock);
+    zoneWatchQuit = true;
+    SDL_mutexV(zoneLock);
+    SDL_WaitThread(zoneWatcher, NULL);
+    zoneWatcher = NULL;
+  }
+  if (zoneLock != NULL) { SDL_DestroyMutex(zoneLock); zoneLock = NULL; }
+}
+//apply_zone_changes
+// ** Runs on the main thread. Only the changed cells are touched; both
+// **  touches_wall() and Tile::show() read the tile type directly, so
+// **  collision and rendering pick up the new type on the next frame.
+void apply_zone_changes(Tile *tiles[]) {
+  if (zoneLock == NULL) { return; }
+  SDL_mutexP(zoneLock);
+  for (unsigned int c = 0; c < zoneChanges.size(); c++) {
+    tiles[zoneChanges[c].index]->set_type(zoneChanges[c].type);
+  }
+  zoneChanges.clear();
+  SDL_mutexV(zoneLock);
+}
+//touches_wall
+bool touches_wall(ZoneRect box, Tile *tiles[], int totalTiles = TOTAL_TILES) {
+  for (int t = 0; t < totalTiles; t++) {
     if ((tiles[t]->get_type() >= TILE_SmallTreeOne)&&(tiles[t]->get_type() <= TILE_RockTwoGrass)) {
       if (check_collision(box,tiles[t]->get_box()) == true) { return true; }
     }
   }//end for
   return false;
 }
+//show_tiles
+void show_tiles(Tile *tiles[], int totalTiles = TOTAL_TILES) {
+  for (int t = 0; t < totalTiles; t++) { tiles[t]->show(); }
+}
 //init
 bool init() {
   if (SDL_Init(SDL_INIT_EVERYTHING) == -1) { return false; }
@@ -513,6 +655,8 @@ bool load_files() {
 }
 //clean_up
 void clean_up(Tile *tiles[]) {
+  stop_zone_watch();
+  
   SDL_FreeSurface(generalScene);
   SDL_FreeSurface(mainCharSpriteSheet);
   
@@ -539,7 +683,8 @@ void Tile::show() {
   }
 }
 int Tile::get_type() { return type; }
-SDL_Rect &Tile::get_box() { return box; }
+void Tile::set_type(int tileType) { type = tileType; }
+ZoneRect &Tile::get_box() { return box; }
 //***TIMER
 Timer::Timer() {
   startTicks = 0;
@@ -607,11 +752,11 @@ void Character::handle_events() {
     }//end switch
   }//end keyup
 }
-void Character::move(Tile *tiles[]) {
+void Character::move(Tile *tiles[], int zoneWidth, int zoneHeight, int totalTiles) {
   box.x += xVel;
-  if ((box.x < 0)||(box.x + CHAR_SPRITE_WIDTH > ZONE_WIDTH)||touches_wall(box,tiles)) { box.x -= xVel; }
+  if ((box.x < 0)||(box.x + CHAR_SPRITE_WIDTH > zoneWidth)||touches_wall(box,tiles,totalTiles)) { box.x -= xVel; }
   box.y += yVel;
-  if ((box.y < 0)||(box.y + CHAR_SPRITE_HEIGHT > ZONE_HEIGHT)||touches_wall(box,tiles)) { box.y -= yVel; }
+  if ((box.y < 0)||(box.y + CHAR_SPRITE_HEIGHT > zoneHeight)||touches_wall(box,tiles,totalTiles)) { box.y -= yVel; }
 }
 void Character::show() {
   if (xVel < 0) { status = DIR_LEFT; frame++; }
@@ -626,14 +771,14 @@ void Character::show() {
   else if (status == DIR_UP) { apply_surface(box.x - camera.x, box.y - camera.y, mainCharSpriteSheet, screen, &mainClipsUp[frame]); }
   else if (status == DIR_DOWN) { apply_surface(box.x - camera.x, box.y - camera.y, mainCharSpriteSheet, screen, &mainClipsDown[frame]); }
 }
-void Character::set_camera() {
+void Character::set_camera(int zoneWidth, int zoneHeight) {
   camera.x = (box.x + CHAR_SPRITE_WIDTH / 2) - SCREEN_WIDTH / 2;
   camera.y = (box.y + CHAR_SPRITE_HEIGHT / 2) - SCREEN_HEIGHT / 2;
   
   if (camera.x < 0) { camera.x = 0; }
   if (camera.y < 0) { camera.y = 0; }
-  if (camera.x > ZONE_WIDTH - camera.w) { camera.x = ZONE_WIDTH - camera.w; }
-  if (camera.y > ZONE_HEIGHT - camera.h) { camera.y = ZONE_HEIGHT - camera.h; }
+  if (camera.x > zoneWidth - camera.w) { camera.x = zoneWidth - camera.w; }
+  if (camera.y > zoneHeight - camera.h) { camera.y = zoneHeight - camera.h; }
 }
 void Character::set_x(int X) { box.x = X; }
 void Character::set_y(int Y) { box.y = Y; }
@@ -647,6 +792,9 @@ int Character::get_status() { return status; }
 //***END CLASS FUNCTIONS***
 //*******************************\\
 //***MAIN
+// ** LoCbench.cpp compiles this file with LOC_BENCHMARK defined and
+// **  supplies its own main().
+#ifndef LOC_BENCHMARK
 int main(int argc, char* args[]) {
 
 bool quit = false;
@@ -658,6 +806,7 @@ if (init() == false) { return 1; }
 if (load_files() == false) { return 1; }
 set_clips();
 if (set_tiles(tiles) == false) { return 1; }
+start_zone_watch();
 
 while (quit == false) {
   //*** EVENTS ***
@@ -668,12 +817,13 @@ while (quit == false) {
   }
   
   //*** LOGIC ***
+  apply_zone_changes(tiles);
   mainChar.set_camera();
   mainChar.move(tiles);
   
   
   //*** RENDER ***
-  for (int t = 0; t < TOTAL_TILES; t++) { tiles[t]->show(); }
+  show_tiles(tiles);
   mainChar.show();
   
   if (SDL_Flip(screen) == -1) { return 1; }
@@ -685,3 +835,4 @@ while (quit == false) {
 clean_up(tiles);
 return 0;
 }
+#endif